@@ -1,7 +1,7 @@
 
-layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec3 in_normal;
-layout (location = 2) in vec2 in_tex_coord;
+layout (location = 0) in vec3 in_position;  // snorm16, relative to the model bounds
+layout (location = 1) in vec2 in_normal;    // snorm16, octahedral encoded
+layout (location = 2) in vec2 in_tex_coord; // half float
 
 out vec4 out_color;
 out vec3 out_position;
@@ -11,11 +11,24 @@ uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
 
+uniform vec3 position_scale;
+uniform vec3 position_offset;
+
+vec3 decode_octahedral(vec2 e) {
+    vec3 n = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
 void main() {
+    vec3 position = in_position * position_scale + position_offset;
+    vec3 normal   = decode_octahedral(in_normal);
+
     out_color = vec4(1, 1, 1, 1);
-    out_position = (view * model * vec4(in_position, 1)).xyz;
-    out_normal = mat3(transpose(inverse(view * model))) * in_normal;
-    gl_Position = projection * view * model * vec4(in_position, 1);
+    out_position = (view * model * vec4(position, 1)).xyz;
+    out_normal = mat3(transpose(inverse(view * model))) * normal;
+    gl_Position = projection * view * model * vec4(position, 1);
 }
 
-
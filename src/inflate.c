@@ -0,0 +1,577 @@
+#include "inflate.h"
+
+#include <string.h>
+
+enum {
+    STATE_STREAM_HEADER,
+    STATE_BLOCK_HEADER,
+    STATE_STORED,
+    STATE_HUFFMAN,
+    STATE_TRAILER,
+    STATE_DONE,
+    STATE_ERROR,
+};
+
+// Returned by the step functions below in place of a result.
+#define NEED_INPUT  (-1)
+#define BAD_STREAM  (-2)
+
+typedef struct {
+    Inflate *inflate;
+    const uint8_t *in;
+    int64_t in_size;
+    int64_t in_pos;
+    uint8_t *out;
+    int64_t out_size;
+    int64_t out_pos;
+} Run;
+
+typedef struct {
+    int64_t in_pos;
+    uint64_t bit_buffer;
+    int32_t bit_count;
+} Checkpoint;
+
+static Checkpoint checkpoint(Run *run) {
+    Checkpoint c;
+    c.in_pos     = run->in_pos;
+    c.bit_buffer = run->inflate->bit_buffer;
+    c.bit_count  = run->inflate->bit_count;
+    return c;
+}
+
+static void rollback(Run *run, Checkpoint c) {
+    run->in_pos = c.in_pos;
+    run->inflate->bit_buffer = c.bit_buffer;
+    run->inflate->bit_count  = c.bit_count;
+}
+
+static void refill(Run *run) {
+    Inflate *s = run->inflate;
+    while (s->bit_count <= 56 && run->in_pos < run->in_size) {
+        s->bit_buffer |= (uint64_t)run->in[run->in_pos++] << s->bit_count;
+        s->bit_count += 8;
+    }
+}
+
+// n <= 32. Returns NEED_INPUT if there aren't enough bits.
+static int64_t get_bits(Run *run, int32_t n) {
+    Inflate *s = run->inflate;
+    if (s->bit_count < n) refill(run);
+    if (s->bit_count < n) return NEED_INPUT;
+
+    uint32_t value = (uint32_t)(s->bit_buffer & ((1ull << n) - 1));
+    s->bit_buffer >>= n;
+    s->bit_count -= n;
+    return value;
+}
+
+static void align_to_byte(Run *run) {
+    Inflate *s = run->inflate;
+    int32_t drop = s->bit_count & 7;
+    s->bit_buffer >>= drop;
+    s->bit_count -= drop;
+}
+
+static int32_t fail(Run *run, const char *message) {
+    run->inflate->error = message;
+    run->inflate->state = STATE_ERROR;
+    return INFLATE_ERROR;
+}
+
+static void emit(Run *run, uint8_t byte) {
+    Inflate *s = run->inflate;
+    run->out[run->out_pos++] = byte;
+    s->window[s->window_pos] = byte;
+    s->window_pos = (s->window_pos + 1) & (INFLATE_WINDOW_SIZE - 1);
+}
+
+// Huffman tables
+
+static uint32_t reverse_bits(uint32_t code, int32_t length) {
+    uint32_t result = 0;
+    for (int32_t i = 0; i < length; i++) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
+
+// Returns 0 on success. Incomplete codes are allowed (a lone distance code is legal),
+// oversubscribed ones aren't.
+static int32_t build_huffman(Inflate_Huffman *h, const uint8_t *lengths, int32_t count) {
+    memset(h->counts, 0, sizeof(h->counts));
+    memset(h->fast, 0, sizeof(h->fast));
+
+    for (int32_t i = 0; i < count; i++) h->counts[lengths[i]]++;
+    h->counts[0] = 0;
+
+    int32_t left = 1;
+    for (int32_t len = 1; len < 16; len++) {
+        left <<= 1;
+        left -= h->counts[len];
+        if (left < 0) return -1;
+    }
+
+    uint16_t offsets[16];
+    uint32_t next_code[16];
+    offsets[1] = 0;
+    next_code[1] = 0;
+    for (int32_t len = 1; len < 15; len++) {
+        offsets[len + 1]   = offsets[len] + h->counts[len];
+        next_code[len + 1] = (next_code[len] + h->counts[len]) << 1;
+    }
+
+    for (int32_t symbol = 0; symbol < count; symbol++) {
+        int32_t len = lengths[symbol];
+        if (len == 0) continue;
+
+        h->symbols[offsets[len]++] = (uint16_t)symbol;
+
+        uint32_t code = next_code[len]++;
+        if (len <= INFLATE_FAST_BITS) {
+            // Codes are sent most significant bit first, the bit buffer is LSB first.
+            uint32_t reversed = reverse_bits(code, len);
+            for (uint32_t i = reversed; i < (1u << INFLATE_FAST_BITS); i += 1u << len) {
+                h->fast[i] = (uint16_t)((symbol << 4) | len);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int32_t decode_symbol(Run *run, const Inflate_Huffman *h) {
+    Inflate *s = run->inflate;
+    if (s->bit_count < 15) refill(run);
+
+    uint16_t entry = h->fast[s->bit_buffer & ((1u << INFLATE_FAST_BITS) - 1)];
+    if (entry) {
+        int32_t len = entry & 15;
+        if (len > s->bit_count) return NEED_INPUT;
+        s->bit_buffer >>= len;
+        s->bit_count -= len;
+        return entry >> 4;
+    }
+
+    // Longer than the fast table covers, walk the canonical code bit by bit.
+    int32_t code = 0, first = 0, index = 0;
+    for (int32_t len = 1; len < 16; len++) {
+        if (s->bit_count < len) return NEED_INPUT;
+        code |= (int32_t)((s->bit_buffer >> (len - 1)) & 1);
+
+        int32_t count = h->counts[len];
+        if (code - first < count) {
+            s->bit_buffer >>= len;
+            s->bit_count -= len;
+            return h->symbols[index + (code - first)];
+        }
+
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    return BAD_STREAM;
+}
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static void build_fixed_tables(Inflate *s) {
+    uint8_t lengths[288];
+    int32_t i = 0;
+    for (; i < 144; i++) lengths[i] = 8;
+    for (; i < 256; i++) lengths[i] = 9;
+    for (; i < 280; i++) lengths[i] = 7;
+    for (; i < 288; i++) lengths[i] = 8;
+    build_huffman(&s->literals, lengths, 288);
+
+    for (i = 0; i < 30; i++) lengths[i] = 5;
+    build_huffman(&s->distances, lengths, 30);
+}
+
+// Checksums
+
+static uint32_t crc_table[256];
+static int32_t  crc_table_ready;
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, int64_t size) {
+    if (!crc_table_ready) {
+        // Idempotent, racing threads just build the same table twice.
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int32_t k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[n] = c;
+        }
+        crc_table_ready = 1;
+    }
+
+    crc = ~crc;
+    for (int64_t i = 0; i < size; i++) crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t adler32_update(uint32_t adler, const uint8_t *data, int64_t size) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (size > 0) {
+        // 5552 is the most bytes that can be summed before b could overflow.
+        int64_t n = size < 5552 ? size : 5552;
+        size -= n;
+        while (n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+// Steps. Each returns 0 when done, NEED_INPUT (after which the caller rolls back), or
+// an INFLATE_ERROR via fail().
+
+static int32_t skip_zero_terminated(Run *run) {
+    for (;;) {
+        int64_t byte = get_bits(run, 8);
+        if (byte < 0) return NEED_INPUT;
+        if (byte == 0) return 0;
+    }
+}
+
+static int32_t read_stream_header(Run *run) {
+    Inflate *s = run->inflate;
+
+    if (s->format == INFLATE_FORMAT_AUTO) {
+        refill(run);
+        if (s->bit_count < 8) return NEED_INPUT;
+        s->format = (s->bit_buffer & 0xFF) == 0x1F ? INFLATE_FORMAT_GZIP : INFLATE_FORMAT_ZLIB;
+    }
+
+    if (s->format == INFLATE_FORMAT_ZLIB) {
+        int64_t cmf = get_bits(run, 8);
+        int64_t flg = get_bits(run, 8);
+        if (cmf < 0 || flg < 0) return NEED_INPUT;
+
+        if ((cmf & 0x0F) != 8)          return fail(run, "zlib: not deflate");
+        if ((cmf * 256 + flg) % 31 != 0) return fail(run, "zlib: bad header check");
+        if (flg & 0x20)                  return fail(run, "zlib: preset dictionaries aren't supported");
+
+        s->checksum = 1;
+        return 0;
+    }
+
+    if (s->format == INFLATE_FORMAT_GZIP) {
+        int64_t id1 = get_bits(run, 8);
+        int64_t id2 = get_bits(run, 8);
+        int64_t cm  = get_bits(run, 8);
+        int64_t flg = get_bits(run, 8);
+        if (flg < 0) return NEED_INPUT;
+
+        if (id1 != 0x1F || id2 != 0x8B) return fail(run, "gzip: bad magic");
+        if (cm != 8)                     return fail(run, "gzip: not deflate");
+
+        // mtime, extra flags, os
+        for (int32_t i = 0; i < 6; i++) if (get_bits(run, 8) < 0) return NEED_INPUT;
+
+        if (flg & 4) { // FEXTRA
+            int64_t length = get_bits(run, 16);
+            if (length < 0) return NEED_INPUT;
+            for (int64_t i = 0; i < length; i++) if (get_bits(run, 8) < 0) return NEED_INPUT;
+        }
+        if ((flg & 8)  && skip_zero_terminated(run) < 0) return NEED_INPUT; // FNAME
+        if ((flg & 16) && skip_zero_terminated(run) < 0) return NEED_INPUT; // FCOMMENT
+        if ((flg & 2)  && get_bits(run, 16) < 0)          return NEED_INPUT; // FHCRC
+
+        s->checksum = 0;
+        return 0;
+    }
+
+    return 0;
+}
+
+static int32_t read_dynamic_tables(Run *run) {
+    Inflate *s = run->inflate;
+
+    int64_t hlit  = get_bits(run, 5);
+    int64_t hdist = get_bits(run, 5);
+    int64_t hclen = get_bits(run, 4);
+    if (hclen < 0) return NEED_INPUT;
+
+    hlit  += 257;
+    hdist += 1;
+    hclen += 4;
+    if (hlit > 286 || hdist > 30) return fail(run, "deflate: too many codes");
+
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    uint8_t lengths[288 + 32];
+    memset(lengths, 0, 19);
+    for (int32_t i = 0; i < hclen; i++) {
+        int64_t len = get_bits(run, 3);
+        if (len < 0) return NEED_INPUT;
+        lengths[order[i]] = (uint8_t)len;
+    }
+
+    // The code length code only lives for this header, borrow the distance table.
+    if (build_huffman(&s->distances, lengths, 19) != 0) return fail(run, "deflate: bad code length code");
+
+    int32_t total = (int32_t)(hlit + hdist);
+    int32_t i = 0;
+    while (i < total) {
+        int32_t symbol = decode_symbol(run, &s->distances);
+        if (symbol == NEED_INPUT) return NEED_INPUT;
+        if (symbol < 0) return fail(run, "deflate: bad code length");
+
+        if (symbol < 16) {
+            lengths[i++] = (uint8_t)symbol;
+            continue;
+        }
+
+        uint8_t value = 0;
+        int64_t repeat;
+        if (symbol == 16) {
+            if (i == 0) return fail(run, "deflate: repeat with no previous length");
+            value = lengths[i - 1];
+            repeat = get_bits(run, 2);
+            if (repeat < 0) return NEED_INPUT;
+            repeat += 3;
+        } else if (symbol == 17) {
+            repeat = get_bits(run, 3);
+            if (repeat < 0) return NEED_INPUT;
+            repeat += 3;
+        } else {
+            repeat = get_bits(run, 7);
+            if (repeat < 0) return NEED_INPUT;
+            repeat += 11;
+        }
+
+        if (i + repeat > total) return fail(run, "deflate: code lengths overflow");
+        while (repeat--) lengths[i++] = value;
+    }
+
+    if (lengths[256] == 0) return fail(run, "deflate: no end of block code");
+
+    if (build_huffman(&s->literals, lengths, (int32_t)hlit) != 0)            return fail(run, "deflate: bad literal code");
+    if (build_huffman(&s->distances, lengths + hlit, (int32_t)hdist) != 0)   return fail(run, "deflate: bad distance code");
+    return 0;
+}
+
+static int32_t read_block_header(Run *run) {
+    Inflate *s = run->inflate;
+
+    int64_t final_block = get_bits(run, 1);
+    int64_t type = get_bits(run, 2);
+    if (type < 0) return NEED_INPUT;
+
+    s->final_block = (int32_t)final_block;
+
+    if (type == 0) {
+        align_to_byte(run);
+        int64_t length  = get_bits(run, 16);
+        int64_t nlength = get_bits(run, 16);
+        if (nlength < 0) return NEED_INPUT;
+        if ((length ^ 0xFFFF) != nlength) return fail(run, "deflate: stored block length mismatch");
+
+        s->stored_remaining = (int32_t)length;
+        s->state = STATE_STORED;
+        return 0;
+    }
+
+    if (type == 1) {
+        build_fixed_tables(s);
+        s->state = STATE_HUFFMAN;
+        return 0;
+    }
+
+    if (type == 2) {
+        int32_t result = read_dynamic_tables(run);
+        if (result != 0) return result;
+        s->state = STATE_HUFFMAN;
+        return 0;
+    }
+
+    return fail(run, "deflate: invalid block type");
+}
+
+static int32_t end_of_block(Inflate *s) {
+    s->state = s->final_block ? STATE_TRAILER : STATE_BLOCK_HEADER;
+    return 0;
+}
+
+static int32_t copy_stored(Run *run) {
+    Inflate *s = run->inflate;
+
+    while (s->stored_remaining > 0 && run->out_pos < run->out_size) {
+        // Whatever the bit buffer already pulled in comes first.
+        if (s->bit_count >= 8) {
+            emit(run, (uint8_t)s->bit_buffer);
+            s->bit_buffer >>= 8;
+            s->bit_count -= 8;
+            s->stored_remaining--;
+            continue;
+        }
+
+        int64_t n = s->stored_remaining;
+        if (n > run->out_size - run->out_pos) n = run->out_size - run->out_pos;
+        if (n > run->in_size - run->in_pos)   n = run->in_size - run->in_pos;
+        if (n == 0) return NEED_INPUT;
+
+        for (int64_t i = 0; i < n; i++) emit(run, run->in[run->in_pos + i]);
+        run->in_pos += n;
+        s->stored_remaining -= (int32_t)n;
+    }
+
+    if (s->stored_remaining == 0) return end_of_block(s);
+    return 0;
+}
+
+// One literal, match or end of block.
+static int32_t decode_one(Run *run) {
+    Inflate *s = run->inflate;
+
+    int32_t symbol = decode_symbol(run, &s->literals);
+    if (symbol == NEED_INPUT) return NEED_INPUT;
+    if (symbol < 0) return fail(run, "deflate: bad literal/length code");
+
+    if (symbol < 256) {
+        emit(run, (uint8_t)symbol);
+        return 0;
+    }
+
+    if (symbol == 256) return end_of_block(s);
+
+    symbol -= 257;
+    if (symbol >= 29) return fail(run, "deflate: bad length symbol");
+
+    int64_t length = get_bits(run, length_extra[symbol]);
+    if (length < 0) return NEED_INPUT;
+    length += length_base[symbol];
+
+    int32_t distance_symbol = decode_symbol(run, &s->distances);
+    if (distance_symbol == NEED_INPUT) return NEED_INPUT;
+    if (distance_symbol < 0 || distance_symbol >= 30) return fail(run, "deflate: bad distance code");
+
+    int64_t distance = get_bits(run, distance_extra[distance_symbol]);
+    if (distance < 0) return NEED_INPUT;
+    distance += distance_base[distance_symbol];
+
+    if ((uint64_t)distance > s->total_out + (uint64_t)run->out_pos) return fail(run, "deflate: distance too far back");
+
+    uint32_t from = (s->window_pos - (uint32_t)distance) & (INFLATE_WINDOW_SIZE - 1);
+    for (int64_t i = 0; i < length; i++) {
+        emit(run, s->window[from]);
+        from = (from + 1) & (INFLATE_WINDOW_SIZE - 1);
+    }
+
+    return 0;
+}
+
+static int32_t read_trailer(Run *run) {
+    Inflate *s = run->inflate;
+    align_to_byte(run);
+
+    if (s->format == INFLATE_FORMAT_ZLIB) {
+        uint32_t adler = 0;
+        for (int32_t i = 0; i < 4; i++) {
+            int64_t byte = get_bits(run, 8);
+            if (byte < 0) return NEED_INPUT;
+            adler = (adler << 8) | (uint32_t)byte;
+        }
+        if (adler != s->checksum) return fail(run, "zlib: checksum mismatch");
+    } else if (s->format == INFLATE_FORMAT_GZIP) {
+        int64_t crc  = get_bits(run, 32);
+        int64_t size = get_bits(run, 32);
+        if (size < 0) return NEED_INPUT;
+        if ((uint32_t)crc != s->checksum)                return fail(run, "gzip: checksum mismatch");
+        if ((uint32_t)size != (uint32_t)s->total_out)    return fail(run, "gzip: size mismatch");
+    }
+
+    s->state = STATE_DONE;
+    return 0;
+}
+
+void inflate_init(Inflate *inflate, int32_t format) {
+    memset(inflate, 0, sizeof(*inflate));
+    inflate->format = format;
+    inflate->state  = format == INFLATE_FORMAT_RAW ? STATE_BLOCK_HEADER : STATE_STREAM_HEADER;
+}
+
+int32_t inflate_run(Inflate *s,
+                    const uint8_t *in, int64_t in_size, int64_t *in_used,
+                    uint8_t *out, int64_t out_size, int64_t *out_written) {
+    Run run;
+    run.inflate  = s;
+    run.in       = in;
+    run.in_size  = in_size;
+    run.in_pos   = 0;
+    run.out      = out;
+    run.out_size = out_size;
+    run.out_pos  = 0;
+
+    int32_t result = INFLATE_NEED_INPUT;
+
+    for (;;) {
+        if (s->state == STATE_ERROR) { result = INFLATE_ERROR; break; }
+        if (s->state == STATE_DONE)  { result = INFLATE_DONE;  break; }
+
+        // Checksums cover everything written up to the trailer.
+        if (s->state == STATE_TRAILER && run.out_pos > 0) break;
+
+        if (s->state == STATE_HUFFMAN && run.out_size - run.out_pos < INFLATE_MIN_OUTPUT) {
+            result = INFLATE_NEED_OUTPUT;
+            break;
+        }
+        if (s->state == STATE_STORED && run.out_pos == run.out_size) {
+            result = INFLATE_NEED_OUTPUT;
+            break;
+        }
+
+        Checkpoint c = checkpoint(&run);
+        int32_t step = 0;
+        switch (s->state) {
+            case STATE_STREAM_HEADER:
+                step = read_stream_header(&run);
+                if (step == 0) s->state = STATE_BLOCK_HEADER;
+                break;
+            case STATE_BLOCK_HEADER: step = read_block_header(&run); break;
+            case STATE_STORED:       step = copy_stored(&run);       break;
+            case STATE_HUFFMAN:      step = decode_one(&run);        break;
+            case STATE_TRAILER:      step = read_trailer(&run);      break;
+        }
+
+        if (step == NEED_INPUT) {
+            // Stored copies keep what they managed, everything else starts over next time.
+            if (s->state != STATE_STORED) rollback(&run, c);
+            result = INFLATE_NEED_INPUT;
+            break;
+        }
+        if (step == INFLATE_ERROR) { result = INFLATE_ERROR; break; }
+    }
+
+    if (run.out_pos > 0) {
+        if (s->format == INFLATE_FORMAT_GZIP) s->checksum = crc32_update(s->checksum, out, run.out_pos);
+        if (s->format == INFLATE_FORMAT_ZLIB) s->checksum = adler32_update(s->checksum, out, run.out_pos);
+        s->total_out += (uint64_t)run.out_pos;
+
+        // The caller may want to know about the output first, the trailer is checked next call.
+        if (result == INFLATE_NEED_INPUT && s->state == STATE_TRAILER) result = INFLATE_NEED_OUTPUT;
+    }
+
+    *in_used     = run.in_pos;
+    *out_written = run.out_pos;
+    return result;
+}
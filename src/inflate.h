@@ -0,0 +1,72 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+// Incremental DEFLATE decoder (RFC 1951) with zlib (RFC 1950) and gzip (RFC 1952)
+// framing. Input and output can both be fed in pieces of any size: inflate_run()
+// decodes as far as it can and says whether it wants more input or more room.
+//
+// Progress is made in whole steps (a header, one literal/match, a stored run). If
+// the input ends in the middle of a step, the step is undone and the unconsumed
+// bytes are reported back, so callers must pass them in again followed by more.
+//
+// Compiled by build.jyu, used through inflate.jyu.
+
+#include <stdint.h>
+
+enum {
+    INFLATE_FORMAT_RAW  = 0,
+    INFLATE_FORMAT_ZLIB = 1,
+    INFLATE_FORMAT_GZIP = 2,
+    INFLATE_FORMAT_AUTO = 3, // zlib or gzip, detected from the first bytes
+};
+
+enum {
+    INFLATE_DONE        = 0, // end of stream reached and checksum verified
+    INFLATE_NEED_INPUT  = 1, // all usable input consumed
+    INFLATE_NEED_OUTPUT = 2, // output space ran low, call again with more
+    INFLATE_ERROR       = 3, // malformed stream, see Inflate.error
+};
+
+enum {
+    // Output buffers smaller than this can't make progress through a long match.
+    INFLATE_MIN_OUTPUT = 258,
+};
+
+#define INFLATE_WINDOW_SIZE 32768
+#define INFLATE_FAST_BITS   10
+
+typedef struct {
+    uint16_t fast[1 << INFLATE_FAST_BITS]; // symbol << 4 | length, 0 if the code is longer
+    uint16_t counts[16];                   // codes of each length
+    uint16_t symbols[288];                 // by code, canonical order
+} Inflate_Huffman;
+
+typedef struct {
+    int32_t format;
+    int32_t state;
+    const char *error;
+
+    uint64_t bit_buffer;
+    int32_t  bit_count;
+
+    int32_t final_block;
+    int32_t stored_remaining;
+
+    Inflate_Huffman literals;
+    Inflate_Huffman distances;
+
+    uint32_t checksum; // CRC-32 for gzip, Adler-32 for zlib
+    uint64_t total_out;
+
+    uint32_t window_pos;
+    uint8_t  window[INFLATE_WINDOW_SIZE];
+} Inflate;
+
+void inflate_init(Inflate *inflate, int32_t format);
+
+// Consumes from in and writes to out, reporting how much of each was used.
+int32_t inflate_run(Inflate *inflate,
+                    const uint8_t *in, int64_t in_size, int64_t *in_used,
+                    uint8_t *out, int64_t out_size, int64_t *out_written);
+
+#endif // INFLATE_H
@@ -0,0 +1,780 @@
+#include "platform.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PLATFORM_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+static __declspec(thread) int32_t current_thread_index = -1;
+#else
+static __thread int32_t current_thread_index = -1;
+#endif
+
+void    thread_index_set(int32_t index) { current_thread_index = index; }
+int32_t thread_index_get(void)          { return current_thread_index; }
+
+typedef struct {
+    Thread_Proc proc;
+    void *user;
+} Thread_Start;
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    Thread_Start start = *(Thread_Start *)param;
+    free(param);
+    start.proc(start.user);
+    return 0;
+}
+
+void *thread_create(Thread_Proc proc, void *user) {
+    Thread_Start *start = malloc(sizeof(Thread_Start));
+    start->proc = proc;
+    start->user = user;
+
+    HANDLE handle = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+    if (!handle) {
+        free(start);
+        return NULL;
+    }
+    return handle;
+}
+
+void thread_join(void *thread) {
+    WaitForSingleObject((HANDLE)thread, INFINITE);
+    CloseHandle((HANDLE)thread);
+}
+
+void thread_sleep_seconds(double seconds) {
+    if (seconds <= 0) return;
+    Sleep((DWORD)(seconds * 1000.0));
+}
+
+void thread_yield(void) {
+    SwitchToThread();
+}
+
+int32_t cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int32_t)info.dwNumberOfProcessors;
+}
+
+void *mutex_create(void) {
+    CRITICAL_SECTION *cs = malloc(sizeof(CRITICAL_SECTION));
+    InitializeCriticalSection(cs);
+    return cs;
+}
+
+void mutex_destroy(void *mutex) {
+    DeleteCriticalSection((CRITICAL_SECTION *)mutex);
+    free(mutex);
+}
+
+void mutex_lock(void *mutex)   { EnterCriticalSection((CRITICAL_SECTION *)mutex); }
+void mutex_unlock(void *mutex) { LeaveCriticalSection((CRITICAL_SECTION *)mutex); }
+
+void *rwlock_create(void) {
+    SRWLOCK *lock = malloc(sizeof(SRWLOCK));
+    InitializeSRWLock(lock);
+    return lock;
+}
+
+void rwlock_destroy(void *lock) { free(lock); }
+
+void rwlock_lock_shared(void *lock)      { AcquireSRWLockShared((SRWLOCK *)lock); }
+void rwlock_unlock_shared(void *lock)    { ReleaseSRWLockShared((SRWLOCK *)lock); }
+void rwlock_lock_exclusive(void *lock)   { AcquireSRWLockExclusive((SRWLOCK *)lock); }
+void rwlock_unlock_exclusive(void *lock) { ReleaseSRWLockExclusive((SRWLOCK *)lock); }
+
+int32_t atomic_load_s32(int32_t *ptr) {
+    return InterlockedCompareExchange((volatile LONG *)ptr, 0, 0);
+}
+
+void atomic_store_s32(int32_t *ptr, int32_t value) {
+    InterlockedExchange((volatile LONG *)ptr, value);
+}
+
+int32_t atomic_exchange_s32(int32_t *ptr, int32_t value) {
+    return InterlockedExchange((volatile LONG *)ptr, value);
+}
+
+int32_t atomic_add_s32(int32_t *ptr, int32_t value) {
+    return InterlockedExchangeAdd((volatile LONG *)ptr, value);
+}
+
+int32_t atomic_compare_exchange_s32(int32_t *ptr, int32_t expected, int32_t desired) {
+    return InterlockedCompareExchange((volatile LONG *)ptr, desired, expected) == expected;
+}
+
+int64_t atomic_load_s64(int64_t *ptr) {
+    return InterlockedCompareExchange64((volatile LONG64 *)ptr, 0, 0);
+}
+
+void atomic_store_s64(int64_t *ptr, int64_t value) {
+    InterlockedExchange64((volatile LONG64 *)ptr, value);
+}
+
+int64_t atomic_add_s64(int64_t *ptr, int64_t value) {
+    return InterlockedExchangeAdd64((volatile LONG64 *)ptr, value);
+}
+
+int32_t atomic_compare_exchange_s64(int64_t *ptr, int64_t expected, int64_t desired) {
+    return InterlockedCompareExchange64((volatile LONG64 *)ptr, desired, expected) == expected;
+}
+
+void *atomic_load_ptr(void **ptr) {
+    return InterlockedCompareExchangePointer((PVOID volatile *)ptr, NULL, NULL);
+}
+
+void atomic_store_ptr(void **ptr, void *value) {
+    InterlockedExchangePointer((PVOID volatile *)ptr, value);
+}
+
+void *file_map(const char *path, int64_t *size) {
+    *size = 0;
+
+    // Sharing writes lets a file_open() handle stay open on the same file.
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return NULL;
+
+    // The view keeps the mapping object alive.
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) return NULL;
+
+    *size = file_size.QuadPart;
+    return data;
+}
+
+void file_unmap(void *data, int64_t size) {
+    (void)size;
+    if (data) UnmapViewOfFile(data);
+}
+
+void *file_open(const char *path) {
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    return file;
+}
+
+int32_t file_write_to(void *file, int64_t offset, const void *data, int64_t size) {
+    int32_t ok = 1;
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (ok && size > 0) {
+        OVERLAPPED at = {0};
+        at.Offset     = (DWORD)offset;
+        at.OffsetHigh = (DWORD)(offset >> 32);
+
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        DWORD written = 0;
+        ok = WriteFile((HANDLE)file, bytes, chunk, &written, &at) && written == chunk;
+
+        bytes  += written;
+        offset += written;
+        size   -= written;
+    }
+    return ok;
+}
+
+int32_t file_close(void *file) {
+    return file ? CloseHandle((HANDLE)file) != 0 : 1;
+}
+
+int32_t file_delete(const char *path) {
+    return DeleteFileA(path) != 0;
+}
+
+#else
+
+static void *thread_entry(void *param) {
+    Thread_Start start = *(Thread_Start *)param;
+    free(param);
+    start.proc(start.user);
+    return NULL;
+}
+
+void *thread_create(Thread_Proc proc, void *user) {
+    Thread_Start *start = malloc(sizeof(Thread_Start));
+    start->proc = proc;
+    start->user = user;
+
+    pthread_t *thread = malloc(sizeof(pthread_t));
+    if (pthread_create(thread, NULL, thread_entry, start) != 0) {
+        free(start);
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void thread_join(void *thread) {
+    pthread_join(*(pthread_t *)thread, NULL);
+    free(thread);
+}
+
+void thread_sleep_seconds(double seconds) {
+    if (seconds <= 0) return;
+
+    struct timespec ts;
+    ts.tv_sec  = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1000000000.0);
+    nanosleep(&ts, NULL);
+}
+
+void thread_yield(void) {
+    sched_yield();
+}
+
+int32_t cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int32_t)count : 1;
+}
+
+void *mutex_create(void) {
+    pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(mutex, NULL);
+    return mutex;
+}
+
+void mutex_destroy(void *mutex) {
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+}
+
+void mutex_lock(void *mutex)   { pthread_mutex_lock((pthread_mutex_t *)mutex); }
+void mutex_unlock(void *mutex) { pthread_mutex_unlock((pthread_mutex_t *)mutex); }
+
+void *rwlock_create(void) {
+    pthread_rwlock_t *lock = malloc(sizeof(pthread_rwlock_t));
+    pthread_rwlock_init(lock, NULL);
+    return lock;
+}
+
+void rwlock_destroy(void *lock) {
+    pthread_rwlock_destroy((pthread_rwlock_t *)lock);
+    free(lock);
+}
+
+void rwlock_lock_shared(void *lock)      { pthread_rwlock_rdlock((pthread_rwlock_t *)lock); }
+void rwlock_unlock_shared(void *lock)    { pthread_rwlock_unlock((pthread_rwlock_t *)lock); }
+void rwlock_lock_exclusive(void *lock)   { pthread_rwlock_wrlock((pthread_rwlock_t *)lock); }
+void rwlock_unlock_exclusive(void *lock) { pthread_rwlock_unlock((pthread_rwlock_t *)lock); }
+
+int32_t atomic_load_s32(int32_t *ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+void atomic_store_s32(int32_t *ptr, int32_t value) {
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+int32_t atomic_exchange_s32(int32_t *ptr, int32_t value) {
+    return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+int32_t atomic_add_s32(int32_t *ptr, int32_t value) {
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+int32_t atomic_compare_exchange_s32(int32_t *ptr, int32_t expected, int32_t desired) {
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+int64_t atomic_load_s64(int64_t *ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+void atomic_store_s64(int64_t *ptr, int64_t value) {
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+int64_t atomic_add_s64(int64_t *ptr, int64_t value) {
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+int32_t atomic_compare_exchange_s64(int64_t *ptr, int64_t expected, int64_t desired) {
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+void *atomic_load_ptr(void **ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+void atomic_store_ptr(void **ptr, void *value) {
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+void *file_map(const char *path, int64_t *size) {
+    *size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    *size = (int64_t)st.st_size;
+    return data;
+}
+
+void file_unmap(void *data, int64_t size) {
+    if (data) munmap(data, (size_t)size);
+}
+
+// The descriptor is stored in a malloc'd int, so handles look the same on both platforms.
+void *file_open(const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) return NULL;
+
+    int *file = malloc(sizeof(int));
+    *file = fd;
+    return file;
+}
+
+int32_t file_write_to(void *file, int64_t offset, const void *data, int64_t size) {
+    int fd = *(int *)file;
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, (size_t)size, (off_t)offset);
+        if (written <= 0) return 0;
+
+        bytes  += written;
+        offset += written;
+        size   -= written;
+    }
+    return 1;
+}
+
+int32_t file_close(void *file) {
+    if (!file) return 1;
+
+    int closed = close(*(int *)file);
+    free(file);
+    return closed == 0;
+}
+
+int32_t file_delete(const char *path) {
+    return unlink(path) == 0;
+}
+
+#endif
+
+int32_t file_write_at(const char *path, int64_t offset, const void *data, int64_t size) {
+    void *file = file_open(path);
+    if (!file) return 0;
+
+    int32_t written = file_write_to(file, offset, data, size);
+    int32_t closed  = file_close(file);
+    return written && closed;
+}
+
+int32_t file_write_all(const char *path, const void *data, int64_t size) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return 0;
+
+    size_t written = size > 0 ? fwrite(data, 1, (size_t)size, file) : 0;
+    int closed = fclose(file);
+    return written == (size_t)size && closed == 0;
+}
+
+// Byte swapping. The wide kernels are compiled for their instruction set regardless of the
+// build flags and only called after checking the CPU supports them.
+
+static uint32_t byteswap32(uint32_t x) {
+    return (x >> 24) | ((x >> 8) & 0xFF00) | ((x << 8) & 0xFF0000) | (x << 24);
+}
+
+static uint64_t byteswap64(uint64_t x) {
+    return ((uint64_t)byteswap32((uint32_t)x) << 32) | byteswap32((uint32_t)(x >> 32));
+}
+
+// memcpy keeps the scalar path free of unaligned/aliasing trouble, compilers turn it into
+// plain loads and stores.
+static void byteswap32_scalar(uint8_t *dst, const uint8_t *src, int64_t count) {
+    for (int64_t i = 0; i < count; i++) {
+        uint32_t v;
+        memcpy(&v, src + i * 4, 4);
+        v = byteswap32(v);
+        memcpy(dst + i * 4, &v, 4);
+    }
+}
+
+static void byteswap64_scalar(uint8_t *dst, const uint8_t *src, int64_t count) {
+    for (int64_t i = 0; i < count; i++) {
+        uint64_t v;
+        memcpy(&v, src + i * 8, 8);
+        v = byteswap64(v);
+        memcpy(dst + i * 8, &v, 8);
+    }
+}
+
+#ifdef PLATFORM_X86
+
+#ifdef _MSC_VER
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+
+enum { SIMD_UNKNOWN = 0, SIMD_NONE, SIMD_SSSE3, SIMD_AVX2 };
+static int32_t simd_level = SIMD_UNKNOWN;
+
+static int32_t detect_simd_level(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    int has_ssse3   = (info[2] >> 9)  & 1;
+    int has_osxsave = (info[2] >> 27) & 1;
+    int has_avx     = (info[2] >> 28) & 1;
+
+    int has_avx2 = 0;
+    if (max_leaf >= 7 && has_osxsave && has_avx) {
+        // The OS also has to save the YMM registers on context switches.
+        unsigned long long xcr0 = _xgetbv(0);
+        if ((xcr0 & 6) == 6) {
+            __cpuidex(info, 7, 0);
+            has_avx2 = (info[1] >> 5) & 1;
+        }
+    }
+#else
+    __builtin_cpu_init();
+    int has_ssse3 = __builtin_cpu_supports("ssse3");
+    int has_avx2  = __builtin_cpu_supports("avx2");
+#endif
+
+    if (has_avx2)  return SIMD_AVX2;
+    if (has_ssse3) return SIMD_SSSE3;
+    return SIMD_NONE;
+}
+
+static int32_t simd_disabled = 0;
+
+static int32_t get_simd_level(void) {
+    if (atomic_load_s32(&simd_disabled)) return SIMD_NONE;
+
+    // Racing threads all compute the same answer, so a plain atomic store is enough.
+    int32_t level = atomic_load_s32(&simd_level);
+    if (level == SIMD_UNKNOWN) {
+        level = detect_simd_level();
+        atomic_store_s32(&simd_level, level);
+    }
+    return level;
+}
+
+TARGET_SSSE3 static void byteswap_ssse3(uint8_t *dst, const uint8_t *src, int64_t bytes, int32_t element_size) {
+    __m128i shuffle = element_size == 4
+        ? _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12)
+        : _mm_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8);
+
+    for (int64_t i = 0; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, shuffle));
+    }
+}
+
+TARGET_AVX2 static void byteswap_avx2(uint8_t *dst, const uint8_t *src, int64_t bytes, int32_t element_size) {
+    // vpshufb shuffles within each 128-bit lane, so both halves use the same pattern.
+    __m256i shuffle = element_size == 4
+        ? _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12, 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12)
+        : _mm256_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8, 7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8);
+
+    for (int64_t i = 0; i + 32 <= bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(v, shuffle));
+    }
+}
+
+// Swaps the largest prefix the vector kernel can handle, returns how many elements that was.
+static int64_t byteswap_simd(uint8_t *dst, const uint8_t *src, int64_t count, int32_t element_size) {
+    int32_t level = get_simd_level();
+    int64_t bytes = count * element_size;
+
+    if (level == SIMD_AVX2) {
+        int64_t done = bytes & ~(int64_t)31;
+        byteswap_avx2(dst, src, done, element_size);
+        return done / element_size;
+    }
+
+    if (level == SIMD_SSSE3) {
+        int64_t done = bytes & ~(int64_t)15;
+        byteswap_ssse3(dst, src, done, element_size);
+        return done / element_size;
+    }
+
+    return 0;
+}
+
+void simd_set_enabled(int32_t enabled) {
+    atomic_store_s32(&simd_disabled, !enabled);
+}
+
+#else
+
+void simd_set_enabled(int32_t enabled) {
+    (void)enabled;
+}
+
+static int64_t byteswap_simd(uint8_t *dst, const uint8_t *src, int64_t count, int32_t element_size) {
+    (void)dst; (void)src; (void)count; (void)element_size;
+    return 0;
+}
+
+#endif // PLATFORM_X86
+
+void byteswap32_array(void *dst, const void *src, int64_t count) {
+    int64_t done = byteswap_simd((uint8_t *)dst, (const uint8_t *)src, count, 4);
+    byteswap32_scalar((uint8_t *)dst + done * 4, (const uint8_t *)src + done * 4, count - done);
+}
+
+void byteswap64_array(void *dst, const void *src, int64_t count) {
+    int64_t done = byteswap_simd((uint8_t *)dst, (const uint8_t *)src, count, 8);
+    byteswap64_scalar((uint8_t *)dst + done * 8, (const uint8_t *)src + done * 8, count - done);
+}
+
+// Gradient noise. The AVX2 kernel does the same float operations in the same order as the
+// scalar one (no fused multiply-add), so both give bit-identical results: terrain only depends
+// on the seed and coordinates, never on which thread or CPU generated it.
+
+#define NOISE_PRIME_X 501125321u
+#define NOISE_PRIME_Y 1136930381u
+#define NOISE_PRIME_Z 1720413743u
+#define NOISE_HASH_MULTIPLIER 0x27D4EB2Du
+
+static uint32_t noise_hash(int32_t seed, int32_t x, int32_t y, int32_t z) {
+    uint32_t h = (uint32_t)seed ^ ((uint32_t)x * NOISE_PRIME_X) ^ ((uint32_t)y * NOISE_PRIME_Y) ^ ((uint32_t)z * NOISE_PRIME_Z);
+    h *= NOISE_HASH_MULTIPLIER;
+    return h ^ (h >> 15);
+}
+
+// Dot product with one of the 12 edge gradients of a cube (16 slots, 4 doubled up), picked by
+// the low hash bits the same way as improved Perlin noise.
+static float noise_gradient(uint32_t hash, float x, float y, float z) {
+    uint32_t g = hash & 15;
+    float u = g < 8 ? x : y;
+    float v = g < 4 ? y : ((g & 13) == 12 ? x : z);
+    return ((g & 1) ? -u : u) + ((g & 2) ? -v : v);
+}
+
+static float noise_fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static float noise_lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+static float gradient_noise_scalar(int32_t seed, float x, float y, float z) {
+    float fx = floorf(x), fy = floorf(y), fz = floorf(z);
+    int32_t x0 = (int32_t)fx, y0 = (int32_t)fy, z0 = (int32_t)fz;
+    float dx = x - fx, dy = y - fy, dz = z - fz;
+
+    float n000 = noise_gradient(noise_hash(seed, x0,     y0,     z0),     dx,        dy,        dz);
+    float n100 = noise_gradient(noise_hash(seed, x0 + 1, y0,     z0),     dx - 1.0f, dy,        dz);
+    float n010 = noise_gradient(noise_hash(seed, x0,     y0 + 1, z0),     dx,        dy - 1.0f, dz);
+    float n110 = noise_gradient(noise_hash(seed, x0 + 1, y0 + 1, z0),     dx - 1.0f, dy - 1.0f, dz);
+    float n001 = noise_gradient(noise_hash(seed, x0,     y0,     z0 + 1), dx,        dy,        dz - 1.0f);
+    float n101 = noise_gradient(noise_hash(seed, x0 + 1, y0,     z0 + 1), dx - 1.0f, dy,        dz - 1.0f);
+    float n011 = noise_gradient(noise_hash(seed, x0,     y0 + 1, z0 + 1), dx,        dy - 1.0f, dz - 1.0f);
+    float n111 = noise_gradient(noise_hash(seed, x0 + 1, y0 + 1, z0 + 1), dx - 1.0f, dy - 1.0f, dz - 1.0f);
+
+    float u = noise_fade(dx), v = noise_fade(dy), w = noise_fade(dz);
+    float x00 = noise_lerp(n000, n100, u);
+    float x10 = noise_lerp(n010, n110, u);
+    float x01 = noise_lerp(n001, n101, u);
+    float x11 = noise_lerp(n011, n111, u);
+    return noise_lerp(noise_lerp(x00, x10, v), noise_lerp(x01, x11, v), w);
+}
+
+static float fbm_scalar(int32_t seed, int32_t octaves, float frequency, float lacunarity, float gain, float x, float y, float z) {
+    float sum = 0.0f, amplitude = 1.0f, total = 0.0f;
+    for (int32_t o = 0; o < octaves; o++) {
+        sum += amplitude * gradient_noise_scalar(seed + o, x * frequency, y * frequency, z * frequency);
+        total += amplitude;
+        amplitude *= gain;
+        frequency *= lacunarity;
+    }
+    return total > 0.0f ? sum / total : 0.0f;
+}
+
+// Warp seeds are offset from the main one so the three offsets and the result don't correlate.
+static void noise_fbm3_scalar(const Noise_Params *p, const float *x, const float *y, const float *z, float *out, int64_t count) {
+    for (int64_t i = 0; i < count; i++) {
+        float px = x[i], py = y[i], pz = z[i];
+
+        if (p->warp_amplitude != 0.0f) {
+            float wx = fbm_scalar(p->seed + 1013, p->warp_octaves, p->warp_frequency, p->lacunarity, p->gain, px, py, pz);
+            float wy = fbm_scalar(p->seed + 2027, p->warp_octaves, p->warp_frequency, p->lacunarity, p->gain, px, py, pz);
+            float wz = fbm_scalar(p->seed + 3037, p->warp_octaves, p->warp_frequency, p->lacunarity, p->gain, px, py, pz);
+            px = px + p->warp_amplitude * wx;
+            py = py + p->warp_amplitude * wy;
+            pz = pz + p->warp_amplitude * wz;
+        }
+
+        out[i] = fbm_scalar(p->seed, p->octaves, p->frequency, p->lacunarity, p->gain, px, py, pz);
+    }
+}
+
+#ifdef PLATFORM_X86
+
+TARGET_AVX2 static inline __m256i noise_hash_avx2(__m256i seed, __m256i x, __m256i y, __m256i z) {
+    __m256i h = _mm256_xor_si256(seed, _mm256_mullo_epi32(x, _mm256_set1_epi32((int32_t)NOISE_PRIME_X)));
+    h = _mm256_xor_si256(h, _mm256_mullo_epi32(y, _mm256_set1_epi32((int32_t)NOISE_PRIME_Y)));
+    h = _mm256_xor_si256(h, _mm256_mullo_epi32(z, _mm256_set1_epi32((int32_t)NOISE_PRIME_Z)));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int32_t)NOISE_HASH_MULTIPLIER));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+}
+
+TARGET_AVX2 static inline __m256 noise_gradient_avx2(__m256i hash, __m256 x, __m256 y, __m256 z) {
+    __m256i g = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+
+    __m256 below8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), g));
+    __m256 below4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), g));
+    __m256 use_x  = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(g, _mm256_set1_epi32(13)), _mm256_set1_epi32(12)));
+
+    __m256 u = _mm256_blendv_ps(y, x, below8);
+    __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, use_x), y, below4);
+
+    // Negating is flipping the sign bit, exactly what the scalar -u does.
+    __m256 u_sign = _mm256_castsi256_ps(_mm256_slli_epi32(g, 31));
+    __m256 v_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(g, 1), 31));
+    return _mm256_add_ps(_mm256_xor_ps(u, u_sign), _mm256_xor_ps(v, v_sign));
+}
+
+TARGET_AVX2 static inline __m256 noise_fade_avx2(__m256 t) {
+    __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+TARGET_AVX2 static inline __m256 noise_lerp_avx2(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+TARGET_AVX2 static inline __m256 gradient_noise_avx2(int32_t seed, __m256 x, __m256 y, __m256 z) {
+    __m256 fx = _mm256_floor_ps(x), fy = _mm256_floor_ps(y), fz = _mm256_floor_ps(z);
+    __m256i x0 = _mm256_cvttps_epi32(fx), y0 = _mm256_cvttps_epi32(fy), z0 = _mm256_cvttps_epi32(fz);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i x1 = _mm256_add_epi32(x0, one), y1 = _mm256_add_epi32(y0, one), z1 = _mm256_add_epi32(z0, one);
+
+    __m256 dx0 = _mm256_sub_ps(x, fx), dy0 = _mm256_sub_ps(y, fy), dz0 = _mm256_sub_ps(z, fz);
+    __m256 onef = _mm256_set1_ps(1.0f);
+    __m256 dx1 = _mm256_sub_ps(dx0, onef), dy1 = _mm256_sub_ps(dy0, onef), dz1 = _mm256_sub_ps(dz0, onef);
+
+    __m256i s = _mm256_set1_epi32(seed);
+    __m256 n000 = noise_gradient_avx2(noise_hash_avx2(s, x0, y0, z0), dx0, dy0, dz0);
+    __m256 n100 = noise_gradient_avx2(noise_hash_avx2(s, x1, y0, z0), dx1, dy0, dz0);
+    __m256 n010 = noise_gradient_avx2(noise_hash_avx2(s, x0, y1, z0), dx0, dy1, dz0);
+    __m256 n110 = noise_gradient_avx2(noise_hash_avx2(s, x1, y1, z0), dx1, dy1, dz0);
+    __m256 n001 = noise_gradient_avx2(noise_hash_avx2(s, x0, y0, z1), dx0, dy0, dz1);
+    __m256 n101 = noise_gradient_avx2(noise_hash_avx2(s, x1, y0, z1), dx1, dy0, dz1);
+    __m256 n011 = noise_gradient_avx2(noise_hash_avx2(s, x0, y1, z1), dx0, dy1, dz1);
+    __m256 n111 = noise_gradient_avx2(noise_hash_avx2(s, x1, y1, z1), dx1, dy1, dz1);
+
+    __m256 u = noise_fade_avx2(dx0), v = noise_fade_avx2(dy0), w = noise_fade_avx2(dz0);
+    __m256 x00 = noise_lerp_avx2(n000, n100, u);
+    __m256 x10 = noise_lerp_avx2(n010, n110, u);
+    __m256 x01 = noise_lerp_avx2(n001, n101, u);
+    __m256 x11 = noise_lerp_avx2(n011, n111, u);
+    return noise_lerp_avx2(noise_lerp_avx2(x00, x10, v), noise_lerp_avx2(x01, x11, v), w);
+}
+
+TARGET_AVX2 static inline __m256 fbm_avx2(int32_t seed, int32_t octaves, float frequency, float lacunarity, float gain, __m256 x, __m256 y, __m256 z) {
+    __m256 sum = _mm256_setzero_ps();
+    float amplitude = 1.0f, total = 0.0f;
+    for (int32_t o = 0; o < octaves; o++) {
+        __m256 f = _mm256_set1_ps(frequency);
+        __m256 n = gradient_noise_avx2(seed + o, _mm256_mul_ps(x, f), _mm256_mul_ps(y, f), _mm256_mul_ps(z, f));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(amplitude), n));
+        total += amplitude;
+        amplitude *= gain;
+        frequency *= lacunarity;
+    }
+    if (total > 0.0f) return _mm256_div_ps(sum, _mm256_set1_ps(total));
+    return _mm256_setzero_ps();
+}
+
+// 8 points per iteration, returns how many were done.
+TARGET_AVX2 static int64_t noise_fbm3_avx2(const Noise_Params *p, const float *x, const float *y, const float *z, float *out, int64_t count) {
+    int64_t done = count & ~(int64_t)7;
+
+    for (int64_t i = 0; i < done; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+
+        if (p->warp_amplitude != 0.0f) {
+            __m256 wx = fbm_avx2(p->seed + 1013, p->warp_octaves, p->warp_frequency, p->lacunarity, p->gain, px, py, pz);
+            __m256 wy = fbm_avx2(p->seed + 2027, p->warp_octaves, p->warp_frequency, p->lacunarity, p->gain, px, py, pz);
+            __m256 wz = fbm_avx2(p->seed + 3037, p->warp_octaves, p->warp_frequency, p->lacunarity, p->gain, px, py, pz);
+            __m256 amplitude = _mm256_set1_ps(p->warp_amplitude);
+            px = _mm256_add_ps(px, _mm256_mul_ps(amplitude, wx));
+            py = _mm256_add_ps(py, _mm256_mul_ps(amplitude, wy));
+            pz = _mm256_add_ps(pz, _mm256_mul_ps(amplitude, wz));
+        }
+
+        _mm256_storeu_ps(out + i, fbm_avx2(p->seed, p->octaves, p->frequency, p->lacunarity, p->gain, px, py, pz));
+    }
+
+    return done;
+}
+
+static int64_t noise_fbm3_simd(const Noise_Params *p, const float *x, const float *y, const float *z, float *out, int64_t count) {
+    if (get_simd_level() == SIMD_AVX2) return noise_fbm3_avx2(p, x, y, z, out, count);
+    return 0;
+}
+
+#else
+
+static int64_t noise_fbm3_simd(const Noise_Params *p, const float *x, const float *y, const float *z, float *out, int64_t count) {
+    (void)p; (void)x; (void)y; (void)z; (void)out; (void)count;
+    return 0;
+}
+
+#endif // PLATFORM_X86
+
+void noise_fbm3(const Noise_Params *params, const float *x, const float *y, const float *z, float *out, int64_t count) {
+    int64_t done = noise_fbm3_simd(params, x, y, z, out, count);
+    noise_fbm3_scalar(params, x + done, y + done, z + done, out + done, count - done);
+}
@@ -0,0 +1,102 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// Small native layer for things jiyu can't express on its own yet: threads,
+// locks, atomic operations, memory-mapped files and SIMD kernels. Compiled by build.jyu alongside nuklear.c and
+// pulled into the game with #clang_import (see platform.jyu).
+
+#include <stdint.h>
+
+typedef void (*Thread_Proc)(void *user);
+
+void *thread_create(Thread_Proc proc, void *user);
+void  thread_join(void *thread);
+void  thread_sleep_seconds(double seconds);
+void  thread_yield(void);
+int32_t cpu_count(void);
+
+// One per-thread integer, used by the job system to find the calling thread's queue.
+void    thread_index_set(int32_t index);
+int32_t thread_index_get(void); // -1 until set
+
+void *mutex_create(void);
+void  mutex_destroy(void *mutex);
+void  mutex_lock(void *mutex);
+void  mutex_unlock(void *mutex);
+
+// Readers-writer lock: any number of shared holders, or one exclusive one.
+void *rwlock_create(void);
+void  rwlock_destroy(void *lock);
+void  rwlock_lock_shared(void *lock);
+void  rwlock_unlock_shared(void *lock);
+void  rwlock_lock_exclusive(void *lock);
+void  rwlock_unlock_exclusive(void *lock);
+
+// All atomics are sequentially consistent. add/exchange return the previous value,
+// compare_exchange returns 1 if the swap happened.
+int32_t atomic_load_s32(int32_t *ptr);
+void    atomic_store_s32(int32_t *ptr, int32_t value);
+int32_t atomic_exchange_s32(int32_t *ptr, int32_t value);
+int32_t atomic_add_s32(int32_t *ptr, int32_t value);
+int32_t atomic_compare_exchange_s32(int32_t *ptr, int32_t expected, int32_t desired);
+
+int64_t atomic_load_s64(int64_t *ptr);
+void    atomic_store_s64(int64_t *ptr, int64_t value);
+int64_t atomic_add_s64(int64_t *ptr, int64_t value);
+int32_t atomic_compare_exchange_s64(int64_t *ptr, int64_t expected, int64_t desired);
+
+void   *atomic_load_ptr(void **ptr);
+void    atomic_store_ptr(void **ptr, void *value);
+
+// Maps the whole file read-only. Returns NULL (and a size of 0) if it can't be opened or
+// is empty. The mapping stays valid until file_unmap, independent of the file handle. It is
+// shared with the file, so later writes to it show up in the mapping, but it doesn't grow
+// with the file.
+void *file_map(const char *path, int64_t *size);
+void  file_unmap(void *data, int64_t size);
+
+// Creates or truncates the file. Returns 1 on success.
+int32_t file_write_all(const char *path, const void *data, int64_t size);
+
+// Writes size bytes at offset, creating the file if needed but keeping what's already in
+// it. Writing past the end grows the file. Returns 1 on success.
+int32_t file_write_at(const char *path, int64_t offset, const void *data, int64_t size);
+
+// The same with the file kept open in between, for files written to over and over. file_open
+// creates the file if needed and returns NULL if it can't. Returns 1 on success.
+void   *file_open(const char *path);
+int32_t file_write_to(void *file, int64_t offset, const void *data, int64_t size);
+int32_t file_close(void *file);
+
+int32_t file_delete(const char *path);
+
+// Reverses the byte order of count 32/64-bit values, e.g. big-endian file data into native
+// integers. dst may equal src for an in-place swap, other overlaps aren't allowed. Picks
+// AVX2 or SSSE3 at runtime when the CPU has them.
+void byteswap32_array(void *dst, const void *src, int64_t count);
+void byteswap64_array(void *dst, const void *src, int64_t count);
+
+// With 0 every SIMD kernel takes its scalar path, for checking and timing them against it.
+void simd_set_enabled(int32_t enabled);
+
+// Fractal (fBm) 3D gradient noise. Each octave adds noise at lacunarity times the previous
+// frequency and gain times its amplitude; the sum is normalized to roughly -1..1. With a
+// nonzero warp_amplitude every point is first moved by three more fBm fields (warp_octaves at
+// warp_frequency), which bends the features of the main field.
+typedef struct {
+    int32_t seed;
+    int32_t octaves;
+    float frequency;
+    float lacunarity;
+    float gain;
+
+    int32_t warp_octaves;
+    float warp_frequency;
+    float warp_amplitude; // 0 turns warping off
+} Noise_Params;
+
+// Samples count points, 8 at a time with AVX2 when the CPU has it. Results are identical
+// either way, so they only depend on the parameters and the points.
+void noise_fbm3(const Noise_Params *params, const float *x, const float *y, const float *z, float *out, int64_t count);
+
+#endif // PLATFORM_H